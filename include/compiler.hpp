@@ -1,9 +1,18 @@
 #pragma once
 
 #include <vcd.hpp>
+#include <liberty.hpp>
 
 namespace compiler {
     namespace compilevcd{
         void compile_vcd_file(const vcd::Vcd& vcd, std::ostream& file);
+        // Compresses the output when filename ends in .gz or .zst; false if the file could not be fully written
+        bool compile_vcd_file(const vcd::Vcd& vcd, const char* filename);
+    }
+    namespace compileliberty{
+        constexpr const char* cache_magic = "LIBC";
+        constexpr uint32_t cache_version = 3;
+
+        void compile_liberty_cache(const liberty::Library& library, const liberty::SourceStamp& stamp, std::ostream& file);
     }
 }
\ No newline at end of file
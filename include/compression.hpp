@@ -0,0 +1,23 @@
+#pragma once
+
+#include <istream>
+#include <ostream>
+#include <memory>
+
+namespace compression {
+    enum class Format {None,Gzip,Zstd};
+
+    // Detected from the first bytes of the file
+    Format detect_format(const char* filename);
+    // Detected from a .gz or .zst suffix
+    Format format_from_extension(const char* filename);
+
+    // Compressed files are decoded on a worker thread that feeds the returned stream through a ring of chunks;
+    // corrupt or truncated input sets badbit on the stream
+    std::unique_ptr<std::istream> open_input(const char* filename);
+    // Compressed output is encoded and written on a worker thread. Call close_output before destroying the stream:
+    // destroying it still flushes, but any write error is then lost
+    std::unique_ptr<std::ostream> open_output(const char* filename, Format format);
+    // Flushes a stream from open_output and waits for its worker; false if anything failed to be written
+    bool close_output(std::ostream& file);
+}
\ No newline at end of file
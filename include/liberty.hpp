@@ -0,0 +1,68 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <optional>
+#include <cstdint>
+
+namespace liberty {
+    enum Logic : uint8_t {False,True,X,Z};
+
+    enum class Op : uint8_t {Const,Var,Not,And,Or,Xor};
+
+    struct Instruction {
+        Op op;
+        uint32_t arg; //Const: Logic value, Var: index in Function::variables
+    };
+
+    // Functions with up to this many variables get a full 4-state truth table
+    constexpr std::size_t max_table_variables = 8;
+
+    struct Function {
+        std::string expression;
+        std::vector<std::string> variables;
+        std::vector<Instruction> code; //postfix bytecode
+        std::string three_state; //output is Z where this is 1, empty if always driven
+        std::vector<Instruction> three_state_code; //over the same variables as code
+        std::vector<Logic> table; //4^variables entries, empty if too many variables
+
+        // inputs are given in the same order as variables
+        Logic evaluate(const Logic* inputs) const;
+        Logic evaluate_code(const Logic* inputs) const;
+    };
+
+    struct Pin {
+        std::string name;
+        std::string direction;
+        std::optional<Function> function;
+    };
+
+    struct Cell {
+        std::string name;
+        std::vector<Pin> pins;
+    };
+
+    struct Library {
+        std::string name;
+        std::vector<Cell> cells;
+    };
+
+    // Identifies the .lib a compiled cache was built from
+    struct SourceStamp {
+        uint64_t size;
+        int64_t time;
+    };
+
+    std::optional<Function> compile_function(const std::string& expression, const std::optional<std::string>& three_state = std::nullopt);
+    // Checks a Function that did not come from compile_function (e.g. read from a cache) is safe to evaluate
+    bool valid_function(const Function& f);
+
+    namespace ast {
+        // Generic Liberty statement: simple attribute (one arg), complex attribute or group
+        struct Statement {
+            std::string name;
+            std::vector<std::string> args;
+            std::vector<Statement> body;
+        };
+    }
+}
\ No newline at end of file
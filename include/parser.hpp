@@ -1,10 +1,20 @@
 #pragma once
 
+#include <istream>
 #include <optional>
 #include <vcd.hpp>
+#include <liberty.hpp>
 
 namespace parser {
     namespace parsevcd{
+        // gzip and zstd files are detected by their magic bytes and decompressed while parsing
         std::optional<vcd::Vcd> parse_vcd_file(const char* filename);
+        std::optional<vcd::Vcd> parse_vcd_string(const std::string& contents);
+    }
+    namespace parseliberty{
+        std::optional<liberty::Library> parse_liberty_file(const char* filename);
+        std::optional<liberty::Library> parse_liberty_cache(std::istream& file, const liberty::SourceStamp& stamp);
+        // Reads cachename if it was built from the current filename, otherwise parses filename and rewrites the cache
+        std::optional<liberty::Library> load_liberty_file(const char* filename, const char* cachename);
     }
 }
\ No newline at end of file
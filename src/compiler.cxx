@@ -1,4 +1,6 @@
 #include <vcd.hpp>
+#include <compiler.hpp>
+#include <compression.hpp>
 
 #include <ostream>
 #include <string>
@@ -8,6 +10,8 @@ namespace compiler {
         void compile_vcd_file(const vcd::Vcd& vcd, std::ostream& file) {
             file << "$date " << vcd.date << " $end" << '\n';
             file << "$version " << vcd.version << " $end" << '\n';
+            if (vcd.comment)
+                file << "$comment " << vcd.comment.value() << " $end" << '\n';
             file << "$timescale " << vcd.timescale << " $end" << '\n';
             for (std::string s:vcd.scope)
                 file << "$scope " << s << " $end" << '\n';
@@ -32,5 +36,65 @@ namespace compiler {
                 }
             }
         }
+
+        bool compile_vcd_file(const vcd::Vcd& vcd, const char* filename) {
+            auto file = compression::open_output(filename, compression::format_from_extension(filename));
+            if (!*file) return false;
+            compile_vcd_file(vcd, *file);
+            return compression::close_output(*file);
+        }
+    }
+    namespace compileliberty{
+        template <typename T>
+        static void write_raw(std::ostream& file, const T& v) {
+            file.write(reinterpret_cast<const char*>(&v), sizeof(T));
+        }
+
+        static void write_string(std::ostream& file, const std::string& s) {
+            write_raw(file, uint32_t(s.size()));
+            file.write(s.data(), s.size());
+        }
+
+        template <typename T>
+        static void write_vector(std::ostream& file, const std::vector<T>& v) {
+            write_raw(file, uint32_t(v.size()));
+            file.write(reinterpret_cast<const char*>(v.data()), std::streamsize(v.size())*sizeof(T));
+        }
+
+        // Field by field, so struct padding never reaches the file
+        static void write_code(std::ostream& file, const std::vector<liberty::Instruction>& code) {
+            write_raw(file, uint32_t(code.size()));
+            for (const liberty::Instruction& i : code) {
+                write_raw(file, uint8_t(i.op));
+                write_raw(file, i.arg);
+            }
+        }
+
+        void compile_liberty_cache(const liberty::Library& library, const liberty::SourceStamp& stamp, std::ostream& file) {
+            file.write(cache_magic, 4);
+            write_raw(file, cache_version);
+            write_raw(file, stamp.size);
+            write_raw(file, stamp.time);
+            write_string(file, library.name);
+            write_raw(file, uint32_t(library.cells.size()));
+            for (const liberty::Cell& cell : library.cells) {
+                write_string(file, cell.name);
+                write_raw(file, uint32_t(cell.pins.size()));
+                for (const liberty::Pin& pin : cell.pins) {
+                    write_string(file, pin.name);
+                    write_string(file, pin.direction);
+                    write_raw(file, uint8_t(pin.function.has_value()));
+                    if (!pin.function) continue;
+                    const liberty::Function& f = pin.function.value();
+                    write_string(file, f.expression);
+                    write_raw(file, uint32_t(f.variables.size()));
+                    for (const std::string& v : f.variables) write_string(file, v);
+                    write_code(file, f.code);
+                    write_string(file, f.three_state);
+                    write_code(file, f.three_state_code);
+                    write_vector(file, f.table);
+                }
+            }
+        }
     }
 }
\ No newline at end of file
@@ -0,0 +1,432 @@
+#include <compression.hpp>
+
+#include <condition_variable>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef HAS_ZLIB
+#include <zlib.h>
+#endif
+#ifdef HAS_ZSTD
+#include <zstd.h>
+#endif
+
+namespace compression {
+    constexpr std::size_t chunk_size = 1 << 18;
+    constexpr std::size_t ring_slots = 8;
+
+    /* Ring of chunks shared by a producer and a consumer thread */
+    class chunk_ring {
+    public:
+        // Swaps chunk into the ring, blocking while it is full; false if the consumer is gone or failed
+        bool push(std::vector<char>& chunk) {
+            std::unique_lock<std::mutex> lock(mutex);
+            not_full.wait(lock, [this] { return count<ring_slots || closed; });
+            if (closed) return false;
+            slots[(head+count)%ring_slots].swap(chunk);
+            ++count;
+            not_empty.notify_one();
+            return true;
+        }
+
+        // Swaps the oldest chunk out of the ring, blocking while it is empty; false once drained
+        bool pop(std::vector<char>& chunk) {
+            std::unique_lock<std::mutex> lock(mutex);
+            not_empty.wait(lock, [this] { return count>0 || finished; });
+            if (count==0) return false;
+            slots[head].swap(chunk);
+            head = (head+1)%ring_slots;
+            --count;
+            not_full.notify_one();
+            return true;
+        }
+
+        // Called by the producer after its last push
+        void finish() {
+            std::lock_guard<std::mutex> lock(mutex);
+            finished = true;
+            not_empty.notify_one();
+        }
+
+        // Called by the consumer when it stops reading early
+        void close() {
+            std::lock_guard<std::mutex> lock(mutex);
+            closed = true;
+            not_full.notify_one();
+        }
+
+        // Called by either side on an error; unblocks both and is reported by failed()
+        void fail() {
+            std::lock_guard<std::mutex> lock(mutex);
+            error = finished = closed = true;
+            not_full.notify_one();
+            not_empty.notify_one();
+        }
+
+        bool failed() {
+            std::lock_guard<std::mutex> lock(mutex);
+            return error;
+        }
+
+    private:
+        std::mutex mutex;
+        std::condition_variable not_full, not_empty;
+        std::vector<char> slots[ring_slots];
+        std::size_t head = 0, count = 0;
+        bool finished = false, closed = false, error = false;
+    };
+    /* Ring of chunks shared by a producer and a consumer thread */
+
+    static bool codec_available(Format format) {
+#ifndef HAS_ZLIB
+        if (format==Format::Gzip) {
+            std::cerr << "Error! gzip support requires zlib\n";
+            return false;
+        }
+#endif
+#ifndef HAS_ZSTD
+        if (format==Format::Zstd) {
+            std::cerr << "Error! zstd support requires libzstd\n";
+            return false;
+        }
+#endif
+        return true;
+    }
+
+    /* Input */
+    // Each decoder returns false on corrupt or truncated input, true on success or when the reader stopped early
+    static bool decompress_gzip([[maybe_unused]] std::ifstream& file, [[maybe_unused]] chunk_ring& ring) {
+#ifdef HAS_ZLIB
+        z_stream z{};
+        if (inflateInit2(&z, 15+32)!=Z_OK) return false;
+
+        std::vector<char> in(chunk_size), out;
+        bool ended = false; //the last member was complete
+        while (file.read(in.data(), in.size()).gcount()>0) {
+            z.next_in = reinterpret_cast<Bytef*>(in.data());
+            z.avail_in = uInt(file.gcount());
+            for (;;) {
+                // Like gzip, bytes after a complete member that do not start another one (e.g. padding) end the stream
+                if (ended && z.avail_in>0 && (z.next_in[0]!=0x1f || (z.avail_in>1 && z.next_in[1]!=0x8b))) {
+                    inflateEnd(&z);
+                    return true;
+                }
+                out.resize(chunk_size);
+                z.next_out = reinterpret_cast<Bytef*>(out.data());
+                z.avail_out = uInt(out.size());
+                int r = inflate(&z, Z_NO_FLUSH);
+                if (r!=Z_OK && r!=Z_STREAM_END && r!=Z_BUF_ERROR) {
+                    std::cerr << "Error! Corrupted gzip stream: " << (z.msg ? z.msg : "unknown") << '\n';
+                    inflateEnd(&z);
+                    return false;
+                }
+                if (r!=Z_BUF_ERROR) ended = r==Z_STREAM_END;
+                out.resize(out.size()-z.avail_out);
+                if (!out.empty() && !ring.push(out)) {
+                    inflateEnd(&z);
+                    return true;
+                }
+                // Concatenated gzip members are decoded as one stream
+                if (r==Z_STREAM_END) inflateReset(&z);
+                if (z.avail_in==0 && z.avail_out!=0) break;
+            }
+        }
+        inflateEnd(&z);
+        if (file.bad() || !ended) {
+            std::cerr << "Error! Truncated gzip stream\n";
+            return false;
+        }
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    static bool decompress_zstd([[maybe_unused]] std::ifstream& file, [[maybe_unused]] chunk_ring& ring) {
+#ifdef HAS_ZSTD
+        ZSTD_DCtx* ctx = ZSTD_createDCtx();
+
+        std::vector<char> in(chunk_size), out;
+        bool ended = false; //the last frame was complete
+        while (file.read(in.data(), in.size()).gcount()>0) {
+            ZSTD_inBuffer input = {in.data(), std::size_t(file.gcount()), 0};
+            for (;;) {
+                out.resize(chunk_size);
+                ZSTD_outBuffer output = {out.data(), out.size(), 0};
+                const std::size_t consumed = input.pos;
+                std::size_t r = ZSTD_decompressStream(ctx, &output, &input);
+                if (ZSTD_isError(r)) {
+                    std::cerr << "Error! Corrupted zstd stream: " << ZSTD_getErrorName(r) << '\n';
+                    ZSTD_freeDCtx(ctx);
+                    return false;
+                }
+                if (input.pos!=consumed || output.pos>0) ended = r==0;
+                out.resize(output.pos);
+                if (!out.empty() && !ring.push(out)) {
+                    ZSTD_freeDCtx(ctx);
+                    return true;
+                }
+                if (input.pos==input.size && output.pos<output.size) break;
+            }
+        }
+        ZSTD_freeDCtx(ctx);
+        if (file.bad() || !ended) {
+            std::cerr << "Error! Truncated zstd stream\n";
+            return false;
+        }
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    class decompress_buf : public std::streambuf {
+    public:
+        decompress_buf(std::ios& owner, const char* filename, Format format) : owner(owner), file(filename, std::ios::binary) {
+            worker = std::thread([this, format] {
+                bool ok = false;
+                if (format==Format::Gzip) ok = decompress_gzip(file, ring);
+                else if (format==Format::Zstd) ok = decompress_zstd(file, ring);
+                if (ok) ring.finish();
+                else ring.fail();
+            });
+        }
+
+        ~decompress_buf() {
+            ring.close();
+            worker.join();
+        }
+
+    protected:
+        // A decode error sets badbit on the owning stream as well as ending it, so readers that
+        // only look for EOF (such as spirit's istream_iterator) still stop, and callers can tell it apart
+        int_type underflow() override {
+            if (gptr()==egptr()) {
+                if (!ring.pop(current)) {
+                    if (ring.failed()) owner.setstate(std::ios::badbit);
+                    return traits_type::eof();
+                }
+                setg(current.data(), current.data(), current.data()+current.size());
+            }
+            return traits_type::to_int_type(*gptr());
+        }
+
+    private:
+        std::ios& owner;
+        std::ifstream file;
+        chunk_ring ring;
+        std::vector<char> current;
+        std::thread worker;
+    };
+
+    class decompress_stream : public std::istream {
+    public:
+        decompress_stream(const char* filename, Format format) : std::istream(nullptr), buf(*this, filename, format) {
+            rdbuf(&buf);
+        }
+
+    private:
+        decompress_buf buf;
+    };
+    /* Input */
+
+    /* Output */
+    // Each encoder returns false if compression failed; the caller then fails the ring so the writer never blocks
+    static bool compress_gzip([[maybe_unused]] std::ofstream& file, [[maybe_unused]] chunk_ring& ring) {
+#ifdef HAS_ZLIB
+        z_stream z{};
+        if (deflateInit2(&z, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15+16, 8, Z_DEFAULT_STRATEGY)!=Z_OK) return false;
+
+        std::vector<char> in, out(chunk_size);
+        bool more = true;
+        while (more) {
+            more = ring.pop(in);
+            z.next_in = reinterpret_cast<Bytef*>(in.data());
+            z.avail_in = more ? uInt(in.size()) : 0;
+            const int flush = more ? Z_NO_FLUSH : Z_FINISH;
+            int r;
+            do {
+                z.next_out = reinterpret_cast<Bytef*>(out.data());
+                z.avail_out = uInt(out.size());
+                r = deflate(&z, flush);
+                if (r==Z_STREAM_ERROR) {
+                    deflateEnd(&z);
+                    return false;
+                }
+                file.write(out.data(), out.size()-z.avail_out);
+            } while (z.avail_out==0 || (flush==Z_FINISH && r!=Z_STREAM_END));
+        }
+        deflateEnd(&z);
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    static bool compress_zstd([[maybe_unused]] std::ofstream& file, [[maybe_unused]] chunk_ring& ring) {
+#ifdef HAS_ZSTD
+        ZSTD_CCtx* ctx = ZSTD_createCCtx();
+        // A content checksum lets the reader reject corrupted frames
+        ZSTD_CCtx_setParameter(ctx, ZSTD_c_checksumFlag, 1);
+
+        std::vector<char> in, out(chunk_size);
+        bool more = true;
+        while (more) {
+            more = ring.pop(in);
+            ZSTD_inBuffer input = {in.data(), more ? in.size() : 0, 0};
+            const ZSTD_EndDirective mode = more ? ZSTD_e_continue : ZSTD_e_end;
+            std::size_t remaining;
+            do {
+                ZSTD_outBuffer output = {out.data(), out.size(), 0};
+                remaining = ZSTD_compressStream2(ctx, &output, &input, mode);
+                if (ZSTD_isError(remaining)) {
+                    std::cerr << "Error! zstd compression failed: " << ZSTD_getErrorName(remaining) << '\n';
+                    ZSTD_freeCCtx(ctx);
+                    return false;
+                }
+                file.write(out.data(), output.pos);
+            } while (mode==ZSTD_e_end ? remaining!=0 : input.pos<input.size);
+        }
+        ZSTD_freeCCtx(ctx);
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    class compress_buf : public std::streambuf {
+    public:
+        compress_buf(const char* filename, Format format) : file(filename, std::ios::binary), open(file.is_open()) {
+            current.resize(chunk_size);
+            setp(current.data(), current.data()+current.size());
+            worker = std::thread([this, format] {
+                bool ok = false;
+                if (format==Format::Gzip) ok = compress_gzip(file, ring);
+                else if (format==Format::Zstd) ok = compress_zstd(file, ring);
+                file.close();
+                if (!ok || file.fail()) ring.fail();
+            });
+        }
+
+        ~compress_buf() {
+            close();
+        }
+
+        bool is_open() const {
+            return open;
+        }
+
+        // Flushes the last chunk and waits for the worker; false if anything failed to be written
+        bool close() {
+            if (worker.joinable()) {
+                const bool pushed = push_chunk();
+                ring.finish();
+                worker.join();
+                ok = pushed && !ring.failed();
+            }
+            return ok;
+        }
+
+    protected:
+        int_type overflow(int_type c) override {
+            if (!push_chunk()) return traits_type::eof();
+            if (!traits_type::eq_int_type(c, traits_type::eof())) {
+                *pptr() = traits_type::to_char_type(c);
+                pbump(1);
+            }
+            return traits_type::not_eof(c);
+        }
+
+        int sync() override {
+            return push_chunk() ? 0 : -1;
+        }
+
+    private:
+        bool push_chunk() {
+            const std::size_t size = pptr()-pbase();
+            if (size==0) return true;
+            current.resize(size);
+            const bool pushed = ring.push(current);
+            current.resize(chunk_size);
+            setp(current.data(), current.data()+current.size());
+            return pushed;
+        }
+
+        std::ofstream file;
+        bool open, ok = false;
+        chunk_ring ring;
+        std::vector<char> current;
+        std::thread worker;
+    };
+
+    class compress_stream : public std::ostream {
+    public:
+        compress_stream(const char* filename, Format format) : std::ostream(nullptr), buf(filename, format) {
+            rdbuf(&buf);
+            if (!buf.is_open()) setstate(std::ios::badbit);
+        }
+
+        bool close() {
+            if (!buf.close()) setstate(std::ios::badbit);
+            return !fail();
+        }
+
+    private:
+        compress_buf buf;
+    };
+    /* Output */
+
+    Format detect_format(const char* filename) {
+        std::ifstream file(filename, std::ios::binary);
+        unsigned char magic[4] = {};
+        file.read(reinterpret_cast<char*>(magic), 4);
+        if (file.gcount()>=2 && magic[0]==0x1f && magic[1]==0x8b) return Format::Gzip;
+        if (file.gcount()==4 && magic[0]==0x28 && magic[1]==0xb5 && magic[2]==0x2f && magic[3]==0xfd) return Format::Zstd;
+        return Format::None;
+    }
+
+    Format format_from_extension(const char* filename) {
+        const std::string name(filename);
+        auto ends_with = [&name](const std::string& suffix) {
+            return name.size()>=suffix.size() && name.compare(name.size()-suffix.size(), suffix.size(), suffix)==0;
+        };
+        if (ends_with(".gz")) return Format::Gzip;
+        if (ends_with(".zst")) return Format::Zstd;
+        return Format::None;
+    }
+
+    std::unique_ptr<std::istream> open_input(const char* filename) {
+        const Format format = detect_format(filename);
+        if (format==Format::None) return std::make_unique<std::ifstream>(filename);
+        if (!codec_available(format)) {
+            auto failed = std::make_unique<std::ifstream>();
+            failed->setstate(std::ios::badbit);
+            return failed;
+        }
+        return std::make_unique<decompress_stream>(filename, format);
+    }
+
+    std::unique_ptr<std::ostream> open_output(const char* filename, Format format) {
+        if (format==Format::None) return std::make_unique<std::ofstream>(filename);
+        if (!codec_available(format)) {
+            auto failed = std::make_unique<std::ofstream>();
+            failed->setstate(std::ios::badbit);
+            return failed;
+        }
+        return std::make_unique<compress_stream>(filename, format);
+    }
+
+    bool close_output(std::ostream& file) {
+        if (auto compressed = dynamic_cast<compress_stream*>(&file)) return compressed->close();
+        file.flush();
+        if (auto plain = dynamic_cast<std::ofstream*>(&file)) {
+            if (plain->is_open()) plain->close();
+        }
+        return !file.fail();
+    }
+}
@@ -0,0 +1,255 @@
+#include <liberty.hpp>
+
+#include <algorithm>
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <boost/spirit/home/x3.hpp>
+
+namespace x3 = boost::spirit::x3;
+
+namespace liberty {
+    namespace expression {
+        struct state {
+            std::vector<Instruction> code;
+            std::vector<std::string> variables;
+        };
+
+        struct state_tag;
+
+        auto emit(Op op) {
+            return [op](auto& ctx) {
+                x3::get<state_tag>(ctx).get().code.push_back({op,0});
+            };
+        }
+
+        auto const emit_const = [](auto& ctx) {
+            x3::get<state_tag>(ctx).get().code.push_back({Op::Const,uint32_t(x3::_attr(ctx)=='1' ? True : False)});
+        };
+
+        auto const emit_var = [](auto& ctx) {
+            state& s = x3::get<state_tag>(ctx).get();
+            const std::string& name = x3::_attr(ctx);
+            auto it = std::find(s.variables.begin(), s.variables.end(), name);
+            if (it==s.variables.end()) {
+                s.variables.push_back(name);
+                it = s.variables.end()-1;
+            }
+            s.code.push_back({Op::Var,uint32_t(it-s.variables.begin())});
+        };
+
+        // Precedence, from highest: ! and ', ^, & * and juxtaposition, | +
+        struct ident_tag;
+        x3::rule<ident_tag, std::string> const ident = "identifier";
+        auto const ident_def = x3::lexeme [ (x3::alpha | x3::char_('_')) >> *(x3::alnum | x3::char_("_[]")) ];
+
+        struct constant_tag;
+        x3::rule<constant_tag, char> const constant = "constant";
+        auto const constant_def = x3::lexeme [ x3::char_("01") >> !(x3::alnum | '_') ];
+
+        struct or_expr_tag;
+        x3::rule<or_expr_tag> const or_expr = "expression";
+
+        struct primary_tag;
+        x3::rule<primary_tag> const primary = "primary";
+        auto const primary_def = ('(' > or_expr > ')') | constant[emit_const] | ident[emit_var];
+
+        struct postfix_tag;
+        x3::rule<postfix_tag> const postfix = "postfix";
+        auto const postfix_def = primary >> *(x3::lit('\'')[emit(Op::Not)]);
+
+        struct unary_tag;
+        x3::rule<unary_tag> const unary = "unary";
+        auto const unary_def = ('!' > unary)[emit(Op::Not)] | postfix;
+
+        struct xor_expr_tag;
+        x3::rule<xor_expr_tag> const xor_expr = "xor";
+        auto const xor_expr_def = unary >> *(('^' > unary)[emit(Op::Xor)]);
+
+        struct and_expr_tag;
+        x3::rule<and_expr_tag> const and_expr = "and";
+        auto const and_expr_def = xor_expr >> *((-(x3::lit('&') | '*') >> xor_expr)[emit(Op::And)]);
+
+        auto const or_expr_def = and_expr >> *(((x3::lit('|') | '+') > and_expr)[emit(Op::Or)]);
+
+        BOOST_SPIRIT_DEFINE(ident,constant,or_expr,primary,postfix,unary,xor_expr,and_expr);
+    }
+
+    static Logic logic_not(Logic a) {
+        if (a==False) return True;
+        if (a==True) return False;
+        return X;
+    }
+
+    static Logic logic_and(Logic a, Logic b) {
+        if (a==False || b==False) return False;
+        if (a==True && b==True) return True;
+        return X;
+    }
+
+    static Logic logic_or(Logic a, Logic b) {
+        if (a==True || b==True) return True;
+        if (a==False && b==False) return False;
+        return X;
+    }
+
+    static Logic logic_xor(Logic a, Logic b) {
+        if (a>True || b>True) return X;
+        return Logic(a^b);
+    }
+
+    static Logic run(const std::vector<Instruction>& code, const Logic* inputs) {
+        Logic local[64] = {};
+        std::vector<Logic> heap;
+        Logic* stack = local;
+        if (code.size()>64) {
+            heap.resize(code.size());
+            stack = heap.data();
+        }
+
+        std::size_t top = 0;
+        for (const Instruction& i : code) {
+            switch (i.op) {
+                case Op::Const :
+                    stack[top++] = Logic(i.arg);
+                    break;
+                case Op::Var :
+                    // A floating input reads as unknown, as it does through every operator
+                    stack[top++] = inputs[i.arg]==Z ? X : inputs[i.arg];
+                    break;
+                case Op::Not :
+                    stack[top-1] = logic_not(stack[top-1]);
+                    break;
+                case Op::And :
+                    --top;
+                    stack[top-1] = logic_and(stack[top-1],stack[top]);
+                    break;
+                case Op::Or :
+                    --top;
+                    stack[top-1] = logic_or(stack[top-1],stack[top]);
+                    break;
+                case Op::Xor :
+                    --top;
+                    stack[top-1] = logic_xor(stack[top-1],stack[top]);
+                    break;
+            }
+        }
+        return stack[0];
+    }
+
+    Logic Function::evaluate_code(const Logic* inputs) const {
+        if (!three_state_code.empty()) {
+            const Logic disabled = run(three_state_code, inputs);
+            if (disabled==True) return Z;
+            if (disabled!=False) return X;
+        }
+        return run(code, inputs);
+    }
+
+    Logic Function::evaluate(const Logic* inputs) const {
+        if (table.empty()) return evaluate_code(inputs);
+
+        std::size_t index = 0;
+        for (std::size_t i=0; i<variables.size(); ++i) {
+            index |= std::size_t(inputs[i]) << (2*i);
+        }
+        return table[index];
+    }
+
+    // Simulates the stack so evaluate_code never reads outside it
+    static bool valid_code(const std::vector<Instruction>& code, std::size_t variables) {
+        std::size_t depth = 0;
+        for (const Instruction& i : code) {
+            switch (i.op) {
+                case Op::Const :
+                    if (i.arg>Z) return false;
+                    ++depth;
+                    break;
+                case Op::Var :
+                    if (i.arg>=variables) return false;
+                    ++depth;
+                    break;
+                case Op::Not :
+                    if (depth<1) return false;
+                    break;
+                case Op::And :
+                case Op::Or :
+                case Op::Xor :
+                    if (depth<2) return false;
+                    --depth;
+                    break;
+                default :
+                    return false;
+            }
+        }
+        return depth==1;
+    }
+
+    bool valid_function(const Function& f) {
+        if (f.variables.size()<=max_table_variables) {
+            if (f.table.size()!=(std::size_t(1) << (2*f.variables.size()))) return false;
+        }
+        else if (!f.table.empty()) return false;
+        for (Logic l : f.table) {
+            if (l>Z) return false;
+        }
+
+        if (f.three_state.empty()!=f.three_state_code.empty()) return false;
+        if (!f.three_state_code.empty() && !valid_code(f.three_state_code, f.variables.size())) return false;
+        return valid_code(f.code, f.variables.size());
+    }
+
+    // Appends the variables of expression to s and leaves only its bytecode in s.code
+    static bool compile_expression(const std::string& expression, expression::state& s) {
+        using iterator = std::string::const_iterator;
+
+        s.code.clear();
+        iterator first = expression.begin(), last = expression.end();
+
+        auto const parserd =
+            x3::with<expression::state_tag>(std::ref(s))
+            [
+                expression::or_expr
+            ];
+
+        bool r;
+        try {
+            r = x3::phrase_parse(first, last, parserd, x3::ascii::space);
+        }
+        catch (const x3::expectation_failure<iterator>&) {
+            return false;
+        }
+        return r && first==last;
+    }
+
+    std::optional<Function> compile_function(const std::string& expression, const std::optional<std::string>& three_state) {
+        expression::state s;
+        Function f;
+        f.expression = expression;
+
+        if (!compile_expression(expression, s)) return std::nullopt;
+        f.code = std::move(s.code);
+        if (three_state) {
+            if (!compile_expression(three_state.value(), s)) return std::nullopt;
+            f.three_state = three_state.value();
+            f.three_state_code = std::move(s.code);
+        }
+        f.variables = std::move(s.variables);
+
+        if (f.variables.size()<=max_table_variables) {
+            const std::size_t n = f.variables.size();
+            f.table.resize(std::size_t(1) << (2*n));
+            std::vector<Logic> inputs(n);
+            for (std::size_t index=0; index<f.table.size(); ++index) {
+                for (std::size_t i=0; i<n; ++i) {
+                    inputs[i] = Logic((index >> (2*i)) & 3);
+                }
+                f.table[index] = f.evaluate_code(inputs.data());
+            }
+        }
+
+        return f;
+    }
+}
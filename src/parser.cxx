@@ -1,12 +1,19 @@
 #include <parser.hpp>
 #include <parser_adapt.hpp>
 
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
 #include <fstream>
+#include <sstream>
 #include <iostream>
 #include <optional>
 #include <vector>
 #include <variant>
 
+#include <compiler.hpp>
+#include <compression.hpp>
+
 
 #include <boost/spirit/home/x3.hpp>
 #include <boost/spirit/include/support_istream_iterator.hpp>
@@ -32,7 +39,7 @@ namespace parser {
     namespace parsevcd {
         struct str_tag;
         x3::rule<str_tag, std::string> const str = "string";
-        auto const str_def = +(x3::lexeme [ +(x3::char_ - '$') ]);
+        auto const str_def = x3::raw [ x3::lexeme [ +(x3::char_ - '$' - x3::space) % +x3::space ] ];
 
         struct date_tag;
         x3::rule<date_tag, std::string> const date = "date";
@@ -68,7 +75,7 @@ namespace parser {
 
         struct dump_tag;
         x3::rule<dump_tag, vcd::Dump> const dump = "dump";
-        auto const dump_def = (x3::lexeme [ ('b' > +value > x3::space) ] | x3::repeat(1)[value]) > ident;
+        auto const dump_def = (x3::lexeme [ ('b' > +value > x3::omit[x3::space]) ] | x3::repeat(1)[value]) > ident;
 
         struct dumpvars_tag;
         x3::rule<dumpvars_tag, std::vector<vcd::Dump>> const dumpvars = "dumpvars";
@@ -125,11 +132,274 @@ namespace parser {
         }
         
         std::optional<vcd::Vcd> parse_vcd_file(const char* filename) {
-            std::ifstream input(filename);
-            input.unsetf(std::ios::skipws);
-            boost::spirit::istream_iterator begin(input);
+            auto input = compression::open_input(filename);
+            input->unsetf(std::ios::skipws);
+            boost::spirit::istream_iterator begin(*input);
             boost::spirit::istream_iterator end;
-            return parse_vcd(begin, end);
+            auto result = parse_vcd(begin, end);
+            // A decode error in compressed input ends the stream early with badbit set
+            if (input->bad()) return std::nullopt;
+            return result;
+        }
+
+        std::optional<vcd::Vcd> parse_vcd_string(const std::string& contents) {
+            return parse_vcd(contents.begin(), contents.end());
+        }
+    }
+    namespace parseliberty {
+        struct name_tag;
+        x3::rule<name_tag, std::string> const name = "name";
+        auto const name_def = x3::lexeme [ +(x3::char_ - (x3::space | x3::char_(";,(){}:\"\\"))) ];
+
+        struct quoted_tag;
+        x3::rule<quoted_tag, std::string> const quoted = "quoted string";
+        auto const quoted_def = x3::lexeme [ '"' > *(x3::char_ - '"') > '"' ];
+
+        struct value_tag;
+        x3::rule<value_tag, std::string> const value = "value";
+        auto const value_def = quoted | name;
+
+        struct args_tag;
+        x3::rule<args_tag, std::vector<std::string>> const args = "arguments";
+        auto const args_def = (':' > x3::repeat(1)[value]) | ('(' > -(value % ',') > ')');
+
+        struct statement_tag;
+        x3::rule<statement_tag, liberty::ast::Statement> const statement = "statement";
+
+        struct body_tag;
+        x3::rule<body_tag, std::vector<liberty::ast::Statement>> const body = "body";
+        auto const body_def = -('{' > *statement > '}') >> -x3::lit(';');
+
+        auto const statement_def = name > args > body;
+
+        struct library_tag;
+        x3::rule<library_tag, liberty::ast::Statement> const library = "library";
+        auto const library_def = "" > statement;
+
+        auto const comment = x3::lit("/*") >> *(x3::char_ - "*/") >> "*/";
+        auto const line_comment = x3::lit("//") >> *(x3::char_ - x3::eol);
+        auto const skipper = x3::space | comment | line_comment | (x3::lit('\\') >> x3::eol);
+
+        BOOST_SPIRIT_DEFINE(name,quoted,value,args,body,statement,library);
+
+        struct library_tag : error_handler {};
+
+        static const liberty::ast::Statement* find_attribute(const liberty::ast::Statement& group, const char* attribute) {
+            for (const liberty::ast::Statement& s : group.body) {
+                if (s.name==attribute && s.body.empty() && s.args.size()==1) return &s;
+            }
+            return nullptr;
+        }
+
+        // Attributes a pin takes from its enclosing bus or bundle unless it sets its own
+        struct pin_attributes {
+            const liberty::ast::Statement* direction = nullptr;
+            const liberty::ast::Statement* function = nullptr;
+            const liberty::ast::Statement* three_state = nullptr;
+        };
+
+        static pin_attributes own_attributes(const liberty::ast::Statement& group, pin_attributes inherited) {
+            if (const liberty::ast::Statement* s = find_attribute(group, "direction")) inherited.direction = s;
+            if (const liberty::ast::Statement* s = find_attribute(group, "function")) inherited.function = s;
+            if (const liberty::ast::Statement* s = find_attribute(group, "three_state")) inherited.three_state = s;
+            return inherited;
+        }
+
+        static void add_pin(const std::string& pin_name, const pin_attributes& attributes, liberty::Cell& cell) {
+            liberty::Pin pin;
+            pin.name = pin_name;
+            if (attributes.direction) pin.direction = attributes.direction->args[0];
+            if (attributes.function) {
+                std::optional<std::string> three_state;
+                if (attributes.three_state) three_state = attributes.three_state->args[0];
+                pin.function = liberty::compile_function(attributes.function->args[0], three_state);
+                if (!pin.function) {
+                    std::cerr << "Error! Unsupported function \"" << attributes.function->args[0] << "\" in " << cell.name << '/' << pin_name << '\n';
+                }
+            }
+            cell.pins.push_back(std::move(pin));
+        }
+
+        static void extract_pins(const liberty::ast::Statement& group, liberty::Cell& cell, const pin_attributes& inherited = {}) {
+            for (const liberty::ast::Statement& s : group.body) {
+                if (s.name=="bus" || s.name=="bundle") {
+                    const pin_attributes attributes = own_attributes(s, inherited);
+                    const std::size_t first = cell.pins.size();
+                    extract_pins(s, cell, attributes);
+                    if (s.name=="bundle") {
+                        // members(...) lists every pin of the bundle, described by a nested pin group or not
+                        for (const liberty::ast::Statement& m : s.body) {
+                            if (m.name!="members" || !m.body.empty()) continue;
+                            for (const std::string& member : m.args) {
+                                auto described = std::find_if(cell.pins.begin()+first, cell.pins.end(), [&](const liberty::Pin& p) { return p.name==member; });
+                                if (described==cell.pins.end()) add_pin(member, attributes, cell);
+                            }
+                        }
+                    }
+                    if (cell.pins.size()==first) {
+                        for (const std::string& pin_name : s.args) add_pin(pin_name, attributes, cell);
+                    }
+                }
+                else if (s.name=="pin") {
+                    const pin_attributes attributes = own_attributes(s, inherited);
+                    for (const std::string& pin_name : s.args) add_pin(pin_name, attributes, cell);
+                }
+            }
+        }
+
+        std::optional<liberty::Library> parse_liberty_file(const char* filename) {
+            std::ifstream input(filename, std::ios::binary);
+            if (!input) return std::nullopt;
+            std::ostringstream contents;
+            contents << input.rdbuf();
+            const std::string buffer = contents.str();
+
+            using iterator = std::string::const_iterator;
+            iterator first = buffer.begin(), last = buffer.end();
+
+            using error_handler_type = x3::error_handler<iterator>;
+            error_handler_type error_handler(first, last, std::cerr);
+
+            auto const parserd =
+                x3::with<x3::error_handler_tag>(std::ref(error_handler))
+                [
+                    parser::parseliberty::library
+                ];
+
+            liberty::ast::Statement root;
+            bool r = x3::phrase_parse(first, last, parserd, skipper, root);
+            if (!r || first!=last || root.name!="library") return std::nullopt;
+
+            liberty::Library output;
+            if (!root.args.empty()) output.name = root.args[0];
+            for (const liberty::ast::Statement& s : root.body) {
+                if (s.name!="cell" || s.args.empty()) continue;
+                liberty::Cell cell;
+                cell.name = s.args[0];
+                extract_pins(s, cell);
+                output.cells.push_back(std::move(cell));
+            }
+            return output;
+        }
+
+        // Bounds-checked reader over a whole cache file, so corrupt lengths never allocate past its size
+        struct cache_reader {
+            const std::string& data;
+            std::size_t pos = 0;
+
+            std::size_t remaining() const {
+                return data.size()-pos;
+            }
+
+            template <typename T>
+            bool read_raw(T& v) {
+                if (remaining()<sizeof(T)) return false;
+                std::memcpy(&v, data.data()+pos, sizeof(T));
+                pos += sizeof(T);
+                return true;
+            }
+
+            // Element counts are capped by the bytes left, as every element takes at least one
+            bool read_count(uint32_t& count) {
+                return read_raw(count) && count<=remaining();
+            }
+
+            bool read_string(std::string& s) {
+                uint32_t size;
+                if (!read_count(size)) return false;
+                s.assign(data.data()+pos, size);
+                pos += size;
+                return true;
+            }
+
+            template <typename T>
+            bool read_vector(std::vector<T>& v) {
+                uint32_t size;
+                if (!read_raw(size) || size>remaining()/sizeof(T)) return false;
+                v.resize(size);
+                if (size>0) std::memcpy(v.data(), data.data()+pos, std::size_t(size)*sizeof(T));
+                pos += std::size_t(size)*sizeof(T);
+                return true;
+            }
+
+            bool read_code(std::vector<liberty::Instruction>& code) {
+                constexpr std::size_t instruction_size = sizeof(uint8_t)+sizeof(uint32_t);
+                uint32_t size;
+                if (!read_raw(size) || size>remaining()/instruction_size) return false;
+                code.resize(size);
+                for (liberty::Instruction& i : code) {
+                    uint8_t op;
+                    read_raw(op);
+                    read_raw(i.arg);
+                    i.op = liberty::Op(op);
+                }
+                return true;
+            }
+        };
+
+        std::optional<liberty::Library> parse_liberty_cache(std::istream& file, const liberty::SourceStamp& stamp) {
+            std::ostringstream contents;
+            contents << file.rdbuf();
+            const std::string buffer = contents.str();
+            cache_reader reader{buffer};
+
+            char magic[4];
+            uint32_t version;
+            liberty::SourceStamp cached;
+            if (!reader.read_raw(magic) || std::string(magic, 4)!=compiler::compileliberty::cache_magic) return std::nullopt;
+            if (!reader.read_raw(version) || version!=compiler::compileliberty::cache_version) return std::nullopt;
+            if (!reader.read_raw(cached.size) || !reader.read_raw(cached.time)) return std::nullopt;
+            if (cached.size!=stamp.size || cached.time!=stamp.time) return std::nullopt;
+
+            liberty::Library output;
+            uint32_t cells;
+            if (!reader.read_string(output.name) || !reader.read_count(cells)) return std::nullopt;
+            output.cells.resize(cells);
+            for (liberty::Cell& cell : output.cells) {
+                uint32_t pins;
+                if (!reader.read_string(cell.name) || !reader.read_count(pins)) return std::nullopt;
+                cell.pins.resize(pins);
+                for (liberty::Pin& pin : cell.pins) {
+                    uint8_t has_function;
+                    if (!reader.read_string(pin.name) || !reader.read_string(pin.direction) || !reader.read_raw(has_function)) return std::nullopt;
+                    if (!has_function) continue;
+                    liberty::Function& f = pin.function.emplace();
+                    uint32_t variables;
+                    if (!reader.read_string(f.expression) || !reader.read_count(variables)) return std::nullopt;
+                    f.variables.resize(variables);
+                    for (std::string& v : f.variables) {
+                        if (!reader.read_string(v)) return std::nullopt;
+                    }
+                    if (!reader.read_code(f.code) || !reader.read_string(f.three_state) || !reader.read_code(f.three_state_code)) return std::nullopt;
+                    if (!reader.read_vector(f.table)) return std::nullopt;
+                    if (!liberty::valid_function(f)) return std::nullopt;
+                }
+            }
+            if (reader.remaining()!=0) return std::nullopt;
+            return output;
+        }
+
+        std::optional<liberty::Library> load_liberty_file(const char* filename, const char* cachename) {
+            std::error_code ec;
+            liberty::SourceStamp stamp;
+            stamp.size = std::filesystem::file_size(filename, ec);
+            if (ec) return std::nullopt;
+            stamp.time = std::filesystem::last_write_time(filename, ec).time_since_epoch().count();
+            if (ec) return std::nullopt;
+
+            std::ifstream cache(cachename, std::ios::binary);
+            if (cache) {
+                auto cached = parse_liberty_cache(cache, stamp);
+                if (cached) return cached;
+            }
+            cache.close();
+
+            auto library = parse_liberty_file(filename);
+            if (library) {
+                std::ofstream out(cachename, std::ios::binary);
+                if (out) compiler::compileliberty::compile_liberty_cache(library.value(), stamp, out);
+            }
+            return library;
         }
     }
 }
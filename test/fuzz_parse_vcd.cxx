@@ -0,0 +1,27 @@
+#include <cstdint>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+
+#include <parser.hpp>
+#include <compiler.hpp>
+
+// libFuzzer entry point: any input the grammar accepts must survive compile -> parse -> compile unchanged
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    const std::string contents(reinterpret_cast<const char*>(data), size);
+
+    auto parsed = parser::parsevcd::parse_vcd_string(contents);
+    if (!parsed) return 0;
+
+    std::ostringstream first;
+    compiler::compilevcd::compile_vcd_file(parsed.value(), first);
+
+    auto reparsed = parser::parsevcd::parse_vcd_string(first.str());
+    if (!reparsed) std::abort();
+
+    std::ostringstream second;
+    compiler::compilevcd::compile_vcd_file(reparsed.value(), second);
+    if (first.str()!=second.str()) std::abort();
+
+    return 0;
+}
@@ -0,0 +1,128 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+
+#include <parser.hpp>
+#include <compiler.hpp>
+#include <compression.hpp>
+
+using std::cout;
+
+// Wall time, since decompression runs on its own thread
+double elapsed(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+std::string compile(const vcd::Vcd& v) {
+    std::ostringstream out;
+    compiler::compilevcd::compile_vcd_file(v, out);
+    return out.str();
+}
+
+int main(int argc, char** argv) {
+    std::ios::sync_with_stdio(0); std::cout.tie(0); std::cin.tie(0);
+
+    if (argc<2) {
+        cout << "Usage: ./TestCompression file.vcd\n";
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    auto reference = parser::parsevcd::parse_vcd_file(argv[1]);
+    if (!reference) {
+        cout << "Parser ERROR\n";
+        return 1;
+    }
+    cout << "Parse: " << elapsed(start) << " seconds\n";
+    const std::string expected = compile(reference.value());
+
+    std::vector<std::string> filenames;
+#ifdef HAS_ZLIB
+    filenames.push_back("bench.vcd.gz");
+#endif
+#ifdef HAS_ZSTD
+    filenames.push_back("bench.vcd.zst");
+#endif
+
+    for (const std::string& filename : filenames) {
+        cout << filename << ":\n";
+
+        start = std::chrono::steady_clock::now();
+        if (!compiler::compilevcd::compile_vcd_file(reference.value(), filename.c_str())) {
+            cout << "  Compile ERROR\n";
+            return 1;
+        }
+        cout << "  Compressed compile: " << elapsed(start) << " seconds\n";
+
+        /* Streaming */
+        start = std::chrono::steady_clock::now();
+        auto streamed = parser::parsevcd::parse_vcd_file(filename.c_str());
+        cout << "  Streaming parse: " << elapsed(start) << " seconds\n";
+        if (!streamed || compile(streamed.value())!=expected) {
+            cout << "  Streaming ERROR\n";
+            return 1;
+        }
+        /* Streaming */
+
+        /* Decompress then parse */
+        const char* plain = "bench_plain.vcd";
+        start = std::chrono::steady_clock::now();
+        {
+            auto input = compression::open_input(filename.c_str());
+            std::ofstream output(plain, std::ios::binary);
+            output << input->rdbuf();
+        }
+        auto staged = parser::parsevcd::parse_vcd_file(plain);
+        cout << "  Decompress then parse: " << elapsed(start) << " seconds\n";
+        std::remove(plain);
+        if (!staged || compile(staged.value())!=expected) {
+            cout << "  Decompress ERROR\n";
+            return 1;
+        }
+        /* Decompress then parse */
+
+        /* Damaged input */
+        std::string compressed;
+        {
+            std::ifstream input(filename, std::ios::binary);
+            std::ostringstream contents;
+            contents << input.rdbuf();
+            compressed = contents.str();
+        }
+        const std::string damaged = "damaged_" + filename;
+        std::string flipped = compressed;
+        for (std::size_t i=flipped.size()/2; i<flipped.size()/2+16 && i<flipped.size(); ++i) flipped[i] ^= 0x5a;
+        for (const std::string& contents : {compressed.substr(0, compressed.size()/2), flipped}) {
+            std::ofstream(damaged, std::ios::binary) << contents;
+            if (parser::parsevcd::parse_vcd_file(damaged.c_str())) {
+                cout << "  Damaged input ERROR: accepted\n";
+                return 1;
+            }
+        }
+        std::remove(damaged.c_str());
+        cout << "  Truncated and corrupted input rejected\n";
+        /* Damaged input */
+
+        /* Padded input */
+        if (filename.size()>3 && filename.compare(filename.size()-3, 3, ".gz")==0) {
+            // gzip ignores bytes after the last member that do not start another one
+            std::ofstream(damaged, std::ios::binary) << compressed << std::string(4, '\0');
+            auto padded = parser::parsevcd::parse_vcd_file(damaged.c_str());
+            std::remove(damaged.c_str());
+            if (!padded || compile(padded.value())!=expected) {
+                cout << "  Padded input ERROR\n";
+                return 1;
+            }
+            cout << "  Zero-padded input accepted\n";
+        }
+        /* Padded input */
+
+        std::remove(filename.c_str());
+    }
+
+    return 0;
+}
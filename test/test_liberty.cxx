@@ -0,0 +1,217 @@
+#include <iostream>
+#include <fstream>
+#include <map>
+#include <random>
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <ctime>
+
+#include <liberty.hpp>
+#include <parser.hpp>
+
+using std::cout;
+
+double elapsed(std::clock_t start) {
+    return ( std::clock() - start ) / (double) CLOCKS_PER_SEC;
+}
+
+struct KnownPin {
+    std::string cell;
+    std::string pin;
+    std::string direction;
+};
+
+struct KnownAnswer {
+    std::string cell;
+    std::string pin;
+    std::map<std::string, liberty::Logic> inputs;
+    liberty::Logic output;
+};
+
+const liberty::Cell* find_cell(const liberty::Library& library, const std::string& cell) {
+    for (const liberty::Cell& c : library.cells) {
+        if (c.name==cell) return &c;
+    }
+    return nullptr;
+}
+
+const liberty::Pin* find_pin(const liberty::Library& library, const std::string& cell, const std::string& pin) {
+    const liberty::Cell* c = find_cell(library, cell);
+    if (!c) return nullptr;
+    for (const liberty::Pin& p : c->pins) {
+        if (p.name==pin) return &p;
+    }
+    return nullptr;
+}
+
+const liberty::Function* find_function(const liberty::Library& library, const std::string& cell, const std::string& pin) {
+    const liberty::Pin* p = find_pin(library, cell, pin);
+    return p && p->function ? &p->function.value() : nullptr;
+}
+
+bool same_code(const std::vector<liberty::Instruction>& a, const std::vector<liberty::Instruction>& b) {
+    if (a.size()!=b.size()) return false;
+    for (std::size_t i=0; i<a.size(); ++i) {
+        if (a[i].op!=b[i].op || a[i].arg!=b[i].arg) return false;
+    }
+    return true;
+}
+
+bool same_function(const liberty::Function& a, const liberty::Function& b) {
+    if (a.expression!=b.expression || a.variables!=b.variables || a.table!=b.table || a.three_state!=b.three_state) return false;
+    return same_code(a.code, b.code) && same_code(a.three_state_code, b.three_state_code);
+}
+
+bool same_library(const liberty::Library& a, const liberty::Library& b) {
+    if (a.name!=b.name || a.cells.size()!=b.cells.size()) return false;
+    for (std::size_t c=0; c<a.cells.size(); ++c) {
+        const liberty::Cell &ca = a.cells[c], &cb = b.cells[c];
+        if (ca.name!=cb.name || ca.pins.size()!=cb.pins.size()) return false;
+        for (std::size_t p=0; p<ca.pins.size(); ++p) {
+            const liberty::Pin &pa = ca.pins[p], &pb = cb.pins[p];
+            if (pa.name!=pb.name || pa.direction!=pb.direction || pa.function.has_value()!=pb.function.has_value()) return false;
+            if (pa.function && !same_function(pa.function.value(), pb.function.value())) return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    std::ios::sync_with_stdio(0); std::cout.tie(0); std::cin.tie(0);
+
+    if (argc<2) {
+        cout << "Usage: ./TestLiberty file.lib [evaluations]\n";
+        return 1;
+    }
+
+    const std::string cachename = std::string(argv[1]) + ".cache";
+    const uint64_t evaluations = argc>2 ? std::stoull(argv[2]) : 10000000;
+
+    /* Load */
+    std::clock_t start = std::clock();
+    auto library = parser::parseliberty::parse_liberty_file(argv[1]);
+    if (!library) {
+        cout << "Parser ERROR\n";
+        return 1;
+    }
+    cout << "Parse and compile time: " << elapsed(start) << " seconds\n";
+
+    std::remove(cachename.c_str());
+    start = std::clock();
+    parser::parseliberty::load_liberty_file(argv[1], cachename.c_str());
+    cout << "Cold load time (parse + write cache): " << elapsed(start) << " seconds\n";
+
+    start = std::clock();
+    auto cached = parser::parseliberty::load_liberty_file(argv[1], cachename.c_str());
+    cout << "Warm load time (read cache): " << elapsed(start) << " seconds\n";
+    /* Load */
+
+    /* Check */
+    if (!cached || !same_library(library.value(), cached.value())) {
+        cout << "Cache ERROR\n";
+        return 1;
+    }
+
+    std::vector<const liberty::Function*> functions;
+    for (const liberty::Cell& c : library->cells) {
+        for (const liberty::Pin& p : c.pins) {
+            if (p.function) functions.push_back(&p.function.value());
+        }
+    }
+
+    // Known answers for the cells of cells.lib; cells missing from other libraries are skipped
+    using liberty::False; using liberty::True; using liberty::X; using liberty::Z;
+    const std::vector<KnownAnswer> answers = {
+        {"INV_X1", "ZN", {{"A",False}}, True},
+        {"INV_X1", "ZN", {{"A",Z}}, X},
+        {"NAND2_X1", "ZN", {{"A1",False},{"A2",X}}, True},
+        {"NAND2_X1", "ZN", {{"A1",True},{"A2",X}}, X},
+        {"NAND2_X1", "ZN", {{"A1",True},{"A2",True}}, False},
+        {"AOI21_X1", "ZN", {{"A",False},{"B1",True},{"B2",True}}, False},
+        {"AOI21_X1", "ZN", {{"A",False},{"B1",False},{"B2",X}}, True},
+        {"AOI21_X1", "ZN", {{"A",X},{"B1",True},{"B2",True}}, False},
+        {"XOR2_X1", "Z", {{"A",True},{"B",False}}, True},
+        {"XOR2_X1", "Z", {{"A",X},{"B",False}}, X},
+        {"XOR2_X1", "Z", {{"A",True},{"B",Z}}, X},
+        // "A S'" is A & !S, not !(A & S)
+        {"MUX2_X1", "Z", {{"A",False},{"B",False},{"S",False}}, False},
+        {"MUX2_X1", "Z", {{"A",True},{"B",False},{"S",False}}, True},
+        {"MUX2_X1", "Z", {{"A",True},{"B",False},{"S",True}}, False},
+        {"MUX2_X1", "Z", {{"A",False},{"B",True},{"S",True}}, True},
+        {"MUX2_X1", "Z", {{"A",True},{"B",True},{"S",X}}, X},
+        {"TIEH", "Z", {}, True},
+        {"DFF_X1", "Q", {{"IQ",Z}}, X},
+        {"TBUF_X1", "Z", {{"A",False},{"EN",True}}, False},
+        {"TBUF_X1", "Z", {{"A",True},{"EN",False}}, Z},
+        {"TBUF_X1", "Z", {{"A",True},{"EN",X}}, X},
+        {"TBUF_X1", "Z", {{"A",True},{"EN",Z}}, X},
+        {"INV_BUS2", "ZN[1]", {{"A[1]",True}}, False},
+    };
+    // Bus and bundle members take the group's attributes unless they set their own
+    const std::vector<KnownPin> pins = {
+        {"INV_BUS2", "A[0]", "input"},
+        {"INV_BUS2", "ZN[1]", "output"},
+        {"INV_BUS2", "S", "input"},
+        {"INV_BUS2", "B0", "inout"},
+        {"INV_BUS2", "B1", "input"},
+    };
+    std::size_t checked = 0;
+    for (const KnownPin& k : pins) {
+        if (!find_cell(library.value(), k.cell)) continue;
+        const liberty::Pin* p = find_pin(library.value(), k.cell, k.pin);
+        if (!p || p->direction!=k.direction) {
+            cout << "Known pin ERROR: " << k.cell << '/' << k.pin << '\n';
+            return 1;
+        }
+        ++checked;
+    }
+    for (const KnownAnswer& a : answers) {
+        const liberty::Function* f = find_function(library.value(), a.cell, a.pin);
+        if (!f) continue;
+        std::vector<liberty::Logic> inputs(f->variables.size(), X);
+        for (std::size_t i=0; i<f->variables.size(); ++i) {
+            auto it = a.inputs.find(f->variables[i]);
+            if (it==a.inputs.end()) {
+                cout << "Known answer ERROR: " << a.cell << '/' << a.pin << " uses " << f->variables[i] << '\n';
+                return 1;
+            }
+            inputs[i] = it->second;
+        }
+        if (f->variables.size()!=a.inputs.size() || f->evaluate(inputs.data())!=a.output || f->evaluate_code(inputs.data())!=a.output) {
+            cout << "Known answer ERROR: " << a.cell << '/' << a.pin << " = " << f->expression << '\n';
+            return 1;
+        }
+        ++checked;
+    }
+    cout << "Cells: " << library->cells.size() << " | Functions: " << functions.size() << " | Known answers: " << checked << '\n';
+    /* Check */
+
+    /* Evaluate */
+    if (functions.empty()) return 0;
+
+    std::mt19937_64 rng(0);
+    std::vector<liberty::Logic> inputs(1<<16);
+    for (liberty::Logic& l : inputs) l = liberty::Logic(rng() & 3);
+
+    uint64_t checksum = 0;
+    start = std::clock();
+    for (uint64_t i=0; i<evaluations; ++i) {
+        const liberty::Function* f = functions[i%functions.size()];
+        checksum += f->evaluate(&inputs[(i*7) & ((1<<16)-64)]);
+    }
+    double t = elapsed(start);
+    cout << "Table evaluation: " << evaluations/t/1e6 << " Mevals/s\n";
+
+    start = std::clock();
+    for (uint64_t i=0; i<evaluations; ++i) {
+        const liberty::Function* f = functions[i%functions.size()];
+        checksum += f->evaluate_code(&inputs[(i*7) & ((1<<16)-64)]);
+    }
+    t = elapsed(start);
+    cout << "Bytecode evaluation: " << evaluations/t/1e6 << " Mevals/s\n";
+    cout << "Checksum: " << checksum << '\n';
+    /* Evaluate */
+
+    return 0;
+}
@@ -47,9 +47,9 @@ int main(int argc, char** argv) {
         mem_usage(vm, rss);
         cout << "Virtual Memory: " << vm << "\nResident set size: " << rss << '\n';
         cout << "Execution time: " << ( std::clock() - start ) / (double) CLOCKS_PER_SEC << " seconds\n";
-        cout << "Date: " << result->date;
-        cout << "Version: " << result->version;
-        cout << "Comment: " << result->comment.value_or("404\n");
+        cout << "Date: " << result->date << '\n';
+        cout << "Version: " << result->version << '\n';
+        cout << "Comment: " << result->comment.value_or("404") << '\n';
         cout << "Timescale: " << result->timescale << '\n';
         cout << "Scopes:\n";
         for (auto &s:result->scope) {
@@ -0,0 +1,207 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <optional>
+#include <random>
+#include <set>
+#include <cstdio>
+#include <ctime>
+
+#include <rapidcheck.h>
+
+#include <parser.hpp>
+#include <compiler.hpp>
+
+/* Equality */
+namespace vcd {
+    bool operator==(const Signal& a, const Signal& b) {
+        return a.type==b.type && a.bitwidth==b.bitwidth && a.id==b.id && a.name==b.name;
+    }
+
+    bool operator==(const Dump& a, const Dump& b) {
+        return a.value==b.value && a.id==b.id;
+    }
+
+    bool operator==(const Timestamp& a, const Timestamp& b) {
+        return a.time==b.time && a.dumps==b.dumps;
+    }
+
+    bool operator==(const Vcd& a, const Vcd& b) {
+        return a.date==b.date && a.version==b.version && a.comment==b.comment && a.timescale==b.timescale
+            && a.scope==b.scope && a.signals==b.signals && a.initial_dump==b.initial_dump && a.timestamps==b.timestamps;
+    }
+}
+/* Equality */
+
+/* Generators */
+// Printable characters without '$', which starts a VCD keyword
+const std::string word_chars = [] {
+    std::string s;
+    for (char c='!'; c<='~'; ++c) if (c!='$') s += c;
+    return s;
+}();
+
+rc::Gen<std::string> word() {
+    return rc::gen::nonEmpty(rc::gen::container<std::string>(rc::gen::elementOf(word_chars)));
+}
+
+// Signal ids may contain '$' (vcd_nand.vcd uses "$"), but must not be a keyword token
+const std::set<std::string> keywords = {
+    "$date", "$version", "$comment", "$timescale", "$scope", "$var", "$upscope",
+    "$enddefinitions", "$dumpvars", "$end"
+};
+
+rc::Gen<std::string> identifier() {
+    std::string chars;
+    for (char c='!'; c<='~'; ++c) chars += c;
+    return rc::gen::suchThat(rc::gen::nonEmpty(rc::gen::container<std::string>(rc::gen::elementOf(chars))), [](const std::string& s) {
+        return keywords.count(s)==0;
+    });
+}
+
+// Free text of a $date/$version/... section, stored without surrounding whitespace
+rc::Gen<std::string> text() {
+    return rc::gen::map(rc::gen::nonEmpty(rc::gen::container<std::vector<std::string>>(word())), [](const std::vector<std::string>& words) {
+        std::string s = words[0];
+        for (std::size_t i=1; i<words.size(); ++i) s += ' ' + words[i];
+        return s;
+    });
+}
+
+namespace rc {
+    template<>
+    struct Arbitrary<vcd::Signal> {
+        static Gen<vcd::Signal> arbitrary() {
+            return gen::build<vcd::Signal>(
+                gen::set(&vcd::Signal::type, gen::nonEmpty(gen::container<std::string>(gen::elementOf(std::string("abcdefghijklmnopqrstuvwxyz"))))),
+                gen::set(&vcd::Signal::bitwidth, gen::inRange(1, 65)),
+                gen::set(&vcd::Signal::id, identifier()),
+                gen::set(&vcd::Signal::name, word())
+            );
+        }
+    };
+
+    template<>
+    struct Arbitrary<vcd::Dump> {
+        static Gen<vcd::Dump> arbitrary() {
+            return gen::build<vcd::Dump>(
+                gen::set(&vcd::Dump::value, gen::nonEmpty(gen::container<std::vector<char>>(gen::elementOf(std::string("01xz"))))),
+                gen::set(&vcd::Dump::id, identifier())
+            );
+        }
+    };
+
+    template<>
+    struct Arbitrary<vcd::Timestamp> {
+        static Gen<vcd::Timestamp> arbitrary() {
+            return gen::build<vcd::Timestamp>(
+                gen::set(&vcd::Timestamp::time),
+                gen::set(&vcd::Timestamp::dumps)
+            );
+        }
+    };
+
+    template<>
+    struct Arbitrary<vcd::Vcd> {
+        static Gen<vcd::Vcd> arbitrary() {
+            return gen::build<vcd::Vcd>(
+                gen::set(&vcd::Vcd::date, text()),
+                gen::set(&vcd::Vcd::version, text()),
+                gen::set(&vcd::Vcd::comment, gen::oneOf(
+                    gen::just(std::optional<std::string>()),
+                    gen::map(text(), [](const std::string& s) { return std::optional<std::string>(s); })
+                )),
+                gen::set(&vcd::Vcd::timescale, text()),
+                gen::set(&vcd::Vcd::scope, gen::container<std::vector<std::string>>(text())),
+                gen::set(&vcd::Vcd::signals, gen::nonEmpty<std::vector<vcd::Signal>>()),
+                gen::set(&vcd::Vcd::initial_dump, gen::nonEmpty<std::vector<vcd::Dump>>()),
+                gen::set(&vcd::Vcd::timestamps, gen::nonEmpty<std::vector<vcd::Timestamp>>())
+            );
+        }
+    };
+}
+/* Generators */
+
+std::string compile(const vcd::Vcd& v) {
+    std::ostringstream out;
+    compiler::compilevcd::compile_vcd_file(v, out);
+    return out.str();
+}
+
+double elapsed(std::clock_t start) {
+    return ( std::clock() - start ) / (double) CLOCKS_PER_SEC;
+}
+
+// Parses a large random VCD from memory and from disk, reporting throughput
+int bench(std::size_t timestamps) {
+    using std::cout;
+
+    // Small random header; the bulk is built directly, without rapidcheck shrink trees,
+    // as 1-8 dumps per timestamp on the header's signals (about 200 bytes per timestamp)
+    vcd::Vcd v = rc::gen::arbitrary<vcd::Vcd>()(rc::Random(), 10).value();
+    std::mt19937_64 rng(0);
+    uint64_t time = 0;
+    v.timestamps.resize(timestamps);
+    for (vcd::Timestamp& t : v.timestamps) {
+        time += 1 + rng()%10;
+        t.time = time;
+        t.dumps.resize(1 + rng()%8);
+        for (vcd::Dump& d : t.dumps) {
+            const vcd::Signal& s = v.signals[rng()%v.signals.size()];
+            d.id = s.id;
+            d.value.resize(s.bitwidth);
+            for (char& c : d.value) c = "01xz"[rng()%4];
+        }
+    }
+
+    const std::string contents = compile(v);
+    const double mb = contents.size() / 1e6;
+    cout << "Input size: " << mb << " MB\n";
+
+    std::clock_t start = std::clock();
+    auto parsed = parser::parsevcd::parse_vcd_string(contents);
+    double t = elapsed(start);
+    if (!parsed || !(parsed.value()==v)) {
+        cout << "Round-trip ERROR\n";
+        return 1;
+    }
+    cout << "parse_vcd_string: " << t << " seconds | " << mb/t << " MB/s\n";
+
+    const char* filename = "roundtrip_bench.vcd";
+    std::ofstream(filename) << contents;
+    start = std::clock();
+    parsed = parser::parsevcd::parse_vcd_file(filename);
+    t = elapsed(start);
+    std::remove(filename);
+    if (!parsed || !(parsed.value()==v)) {
+        cout << "Round-trip ERROR\n";
+        return 1;
+    }
+    cout << "parse_vcd_file: " << t << " seconds | " << mb/t << " MB/s\n";
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    std::ios::sync_with_stdio(0); std::cout.tie(0); std::cin.tie(0);
+
+    if (argc>1 && std::string(argv[1])=="bench") {
+        return bench(argc>2 ? std::stoull(argv[2]) : 100000);
+    }
+
+    bool ok = rc::check("parse(compile(v)) == v", [](const vcd::Vcd& v) {
+        auto parsed = parser::parsevcd::parse_vcd_string(compile(v));
+        RC_ASSERT(parsed.has_value());
+        RC_ASSERT(parsed.value()==v);
+    });
+
+    ok &= rc::check("compile is a fixed point after one parse", [](const vcd::Vcd& v) {
+        const std::string first = compile(v);
+        auto parsed = parser::parsevcd::parse_vcd_string(first);
+        RC_ASSERT(parsed.has_value());
+        RC_ASSERT(compile(parsed.value())==first);
+    });
+
+    return ok ? 0 : 1;
+}